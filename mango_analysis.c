@@ -2,6 +2,7 @@
 
 #define NUM_SIMULACIONES 10
 #define MAX_INTENTOS_ROBOT 15
+#define MAX_PUNTOS_LATENCIA 64
 
 // Para guardar los resultados
 typedef struct {
@@ -11,8 +12,14 @@ typedef struct {
     float tiempo_promedio;
     int exitos;
     int fallos;
+    float cola_promedio;   // solo con vision
+    int cola_maxima;
 } ResultadoAnalisis;
 
+// Con MANGO_TRAZA se guarda una traza por corrida, numeradas en orden
+static const char *ruta_traza = NULL;
+static int corridas_trazadas = 0;
+
 // Corre varias simulaciones y calcula el promedio
 ResultadoAnalisis analizar_configuracion(ConfiguracionSistema *config, 
                                          int num_simulaciones) {
@@ -22,6 +29,8 @@ ResultadoAnalisis analizar_configuracion(ConfiguracionSistema *config,
     resultado.exitos = 0;
     resultado.fallos = 0;
     resultado.tiempo_promedio = 0.0;
+    resultado.cola_promedio = 0.0;
+    resultado.cola_maxima = 0;
     
     printf("\nAnalizando: %d robots, %d mangos", 
            config->num_robots, config->num_mangos);
@@ -33,13 +42,34 @@ ResultadoAnalisis analizar_configuracion(ConfiguracionSistema *config,
     for (int i = 0; i < num_simulaciones; i++) {
         int mangos_etiquetados;
         
+        // Todas las configuraciones ven las mismas cajas, asi se comparan mejor
+        config->indice_simulacion = i;
+        
+        traza_reiniciar();
         clock_t inicio = clock();
         int exito = simular_etiquetado(config, &mangos_etiquetados);
         clock_t fin = clock();
         
+        if (ruta_traza != NULL) {
+            char sufijo[48], ruta[256];
+            snprintf(sufijo, sizeof(sufijo), "_%03d_r%d_m%d",
+                     corridas_trazadas++, config->num_robots, config->num_mangos);
+            traza_ruta(ruta, sizeof(ruta), ruta_traza, sufijo);
+            traza_exportar_chrome(ruta, config->num_robots);
+        }
+        
         double tiempo_sim = (double)(fin - inicio) / CLOCKS_PER_SEC;
         resultado.tiempo_promedio += tiempo_sim;
         
+        if (config->usar_vision) {
+            MetricasVision metricas;
+            obtener_metricas_vision(&metricas);
+            resultado.cola_promedio += metricas.cola_promedio;
+            if (metricas.cola_maxima > resultado.cola_maxima) {
+                resultado.cola_maxima = metricas.cola_maxima;
+            }
+        }
+        
         if (exito == 1) {
             resultado.exitos++;
             printf("  [%d/%d] ✓ Éxito (%.2fs)\n", 
@@ -56,6 +86,7 @@ ResultadoAnalisis analizar_configuracion(ConfiguracionSistema *config,
     }
     
     resultado.tiempo_promedio /= num_simulaciones;
+    resultado.cola_promedio /= num_simulaciones;
     resultado.tasa_exito = (float)resultado.exitos / num_simulaciones;
     
     return resultado;
@@ -210,9 +241,77 @@ void analizar_con_redundancia(ConfiguracionSistema *config_base,
     printf("\nResultados guardados en: analisis_redundancia.csv\n");
 }
 
-int main(int argc, char *argv[]) {
-    srand(time(NULL));
+// Ve como la latencia de la etapa de vision cambia los robots necesarios
+void analizar_latencia_vision(ConfiguracionSistema *config_base,
+                              float latencia_max,
+                              float paso_latencia,
+                              int num_simulaciones) {
+    printf("\n=== ANÁLISIS DE LATENCIA DE VISIÓN ===\n");
+    printf("Mangos: %d | Latencia: 0 - %.2fs (paso %.2fs)\n", 
+           config_base->num_mangos, latencia_max, paso_latencia);
+    printf("Cámara en %.2f cm | Detección: %.3fs por mango | Cola de %d\n", 
+           config_base->posicion_camara, config_base->tiempo_por_mango, 
+           config_base->capacidad_cola);
+    
+    FILE *archivo = fopen("analisis_vision.csv", "w");
+    if (archivo == NULL) {
+        perror("Error abriendo archivo");
+        return;
+    }
+    
+    fprintf(archivo, "LatenciaVisión,RobotsMínimos,TasaÉxito,"
+            "ColaPromedio,ColaMáxima,TiempoPromedio\n");
+    
+    ConfiguracionSistema config = *config_base;
+    config.usar_vision = 1;
+    
+    // Para la tabla final
+    // main ya reviso que el barrido quepa
+    float latencias[MAX_PUNTOS_LATENCIA];
+    ResultadoAnalisis resultados[MAX_PUNTOS_LATENCIA];
+    int robots[MAX_PUNTOS_LATENCIA];
+    int num_puntos = 0;
+    
+    for (float latencia = 0.0; latencia <= latencia_max + 1e-4 && 
+         num_puntos < MAX_PUNTOS_LATENCIA; latencia += paso_latencia) {
+        config.latencia_vision = latencia;
+        
+        int robots_optimos = encontrar_num_robots_optimo(&config, 0.95, 
+                                                         num_simulaciones);
+        if (robots_optimos <= 0) {
+            fprintf(archivo, "%.3f,-1,0.000,0.000,0,0.000\n", latencia);
+            continue;
+        }
+        
+        config.num_robots = robots_optimos;
+        ResultadoAnalisis resultado = analizar_configuracion(&config, 
+                                                             num_simulaciones);
+        
+        fprintf(archivo, "%.3f,%d,%.3f,%.3f,%d,%.3f\n", 
+                latencia, robots_optimos, resultado.tasa_exito, 
+                resultado.cola_promedio, resultado.cola_maxima, 
+                resultado.tiempo_promedio);
+        
+        latencias[num_puntos] = latencia;
+        robots[num_puntos] = robots_optimos;
+        resultados[num_puntos] = resultado;
+        num_puntos++;
+    }
+    
+    fclose(archivo);
+    
+    printf("\nLatencia | Robots | Tasa Éxito | Cola prom. | Cola máx.\n");
+    printf("---------|--------|------------|------------|----------\n");
+    for (int i = 0; i < num_puntos; i++) {
+        printf("%7.2fs | %6d | %9.1f%% | %10.2f | %9d\n", 
+               latencias[i], robots[i], resultados[i].tasa_exito * 100, 
+               resultados[i].cola_promedio, resultados[i].cola_maxima);
+    }
     
+    printf("\nResultados guardados en: analisis_vision.csv\n");
+}
+
+int main(int argc, char *argv[]) {
     // Config por defecto
     ConfiguracionSistema config_base;
     config_base.velocidad_banda = 10.0;
@@ -220,22 +319,52 @@ int main(int argc, char *argv[]) {
     config_base.longitud_banda = 300.0;  // banda mas larga para dar mas tiempo
     config_base.prob_fallo = 0.0;
     config_base.usar_redundancia = 0;
+    config_base.id_linea = 0;
+    config_base.semilla = (unsigned long)time(NULL);
+    config_base.indice_simulacion = 0;
+    config_base.usar_vision = 0;
+    config_base.posicion_camara = 0.0;
+    config_base.latencia_vision = 0.0;
+    config_base.tiempo_por_mango = 0.0;
+    config_base.capacidad_cola = MAX_MANGOS;
+    config_base.cola_vision = NULL;
+    config_base.secuencia_caja = 0;
     
     if (argc < 2) {
-        printf("Uso: %s <modo> [opciones]\n", argv[0]);
+        printf("Uso: %s <modo> [opciones] [semilla]\n", argv[0]);
         printf("\nModos:\n");
         printf("  1 - Análisis simple (encontrar robots óptimos)\n");
         printf("  2 - Generar curva robots vs mangos\n");
         printf("  3 - Análisis con redundancia\n");
+        printf("  4 - Latencia de visión vs robots necesarios\n");
         printf("\nEjemplos:\n");
         printf("  %s 1 20 5          # Encontrar robots para 20 mangos, 5 simulaciones\n", argv[0]);
         printf("  %s 2 10 30 5 3     # Curva de 10-30 mangos, incr=5, 3 sims\n", argv[0]);
         printf("  %s 3 20 5 0.05 5   # 20 mangos, 5 robots base, 5%% fallo, 5 sims\n", argv[0]);
+        printf("  %s 4 10 2 2.0 0.5 0.1 5  # 10 mangos, 2 sims, latencia 0-2s (paso 0.5),\n"
+               "                            # 0.1s por mango, cola de 5\n", argv[0]);
+        printf("  %s 1 20 5 42       # Igual que el primero, con semilla fija\n", argv[0]);
         return 1;
     }
     
+    // Traza opcional, una por corrida: MANGO_TRAZA=traza.json ./mango_analysis ...
+    ruta_traza = getenv("MANGO_TRAZA");
+    if (ruta_traza != NULL && traza_iniciar(TRAZA_CAPACIDAD) == -1) {
+        ruta_traza = NULL;
+    }
+    
     int modo = atoi(argv[1]);
     
+    // La semilla es el ultimo parametro de cada modo (opcional). Se imprime
+    // para poder repetir la corrida
+    if (modo >= 1 && modo <= 4) {
+        int arg_semilla = (modo == 1) ? 4 : (modo == 4) ? 9 : 6;
+        if (argc > arg_semilla) {
+            config_base.semilla = strtoul(argv[arg_semilla], NULL, 10);
+        }
+        printf("Semilla: %lu\n", config_base.semilla);
+    }
+    
     switch (modo) {
         case 1: {
             // Buscar robots optimos
@@ -312,10 +441,61 @@ int main(int argc, char *argv[]) {
             break;
         }
         
+        case 4: {
+            // Latencia de vision
+            int num_mangos = (argc >= 3) ? atoi(argv[2]) : 10;
+            int num_sims = (argc >= 4) ? atoi(argv[3]) : 3;
+            float latencia_max = (argc >= 5) ? atof(argv[4]) : 2.0;
+            float paso_latencia = (argc >= 6) ? atof(argv[5]) : 0.5;
+            float tiempo_por_mango = (argc >= 7) ? atof(argv[6]) : 0.1;
+            int capacidad_cola = (argc >= 8) ? atoi(argv[7]) : MAX_MANGOS;
+            float posicion_camara = (argc >= 9) ? atof(argv[8]) : 0.0;
+            
+            if (num_mangos <= 0 || num_mangos > MAX_MANGOS) {
+                printf("Error: Número de mangos debe estar entre 1 y %d\n", MAX_MANGOS);
+                return 1;
+            }
+            if (num_sims <= 0) {
+                printf("Error: Número de simulaciones debe ser positivo\n");
+                return 1;
+            }
+            // Escrito al reves para que NaN tambien sea error
+            if (!(latencia_max >= 0 && paso_latencia > 0 && tiempo_por_mango >= 0) ||
+                !isfinite(latencia_max) || !isfinite(tiempo_por_mango)) {
+                printf("Error: Latencia y paso deben ser positivos\n");
+                return 1;
+            }
+            if (latencia_max / paso_latencia >= MAX_PUNTOS_LATENCIA) {
+                printf("Error: Máximo %d puntos de latencia (latencia_max / paso < %d)\n",
+                       MAX_PUNTOS_LATENCIA, MAX_PUNTOS_LATENCIA);
+                return 1;
+            }
+            if (capacidad_cola <= 0 || capacidad_cola > MAX_MANGOS) {
+                printf("Error: Capacidad de cola debe estar entre 1 y %d\n", MAX_MANGOS);
+                return 1;
+            }
+            if (!(posicion_camara >= 0 && 
+                  posicion_camara <= config_base.longitud_banda)) {
+                printf("Error: La cámara debe estar entre 0 y %.2f cm (la banda)\n",
+                       config_base.longitud_banda);
+                return 1;
+            }
+            
+            config_base.num_mangos = num_mangos;
+            config_base.posicion_camara = posicion_camara;
+            config_base.tiempo_por_mango = tiempo_por_mango;
+            config_base.capacidad_cola = capacidad_cola;
+            
+            analizar_latencia_vision(&config_base, latencia_max, paso_latencia, 
+                                     num_sims);
+            break;
+        }
+        
         default:
             printf("Modo inválido: %d\n", modo);
             return 1;
     }
     
+    traza_liberar();
     return 0;
 }
\ No newline at end of file
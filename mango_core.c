@@ -4,6 +4,9 @@
 static int shm_fd = -1;
 static sem_t *sem_mutex = NULL;
 static EstadoSistema *estado_compartido = NULL;
+static char nombre_shm[64];
+static char nombre_mutex[64];
+static MetricasVision ultimas_metricas_vision;
 
 // Para manejar Ctrl+C
 void signal_handler(int signo) {
@@ -23,12 +26,12 @@ void cleanup_recursos() {
     }
     if (shm_fd != -1) {
         close(shm_fd);
-        shm_unlink(SHM_NAME);
+        shm_unlink(nombre_shm);
         shm_fd = -1;
     }
     if (sem_mutex != NULL) {
         sem_close(sem_mutex);
-        sem_unlink(SEM_MUTEX_NAME);
+        sem_unlink(nombre_mutex);
         sem_mutex = NULL;
     }
 }
@@ -65,23 +68,56 @@ void calcular_posiciones_robots(EstadoSistema *estado, float longitud_banda,
     }
 }
 
+// Mezcla de bits de splitmix64
+static uint64_t mezclar_bits(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Numero en [0, 1) que sale de la clave, sin estado global como rand(),
+// asi cada proceso o corrida en paralelo saca su propia secuencia
+double aleatorio_contador(unsigned long semilla, int indice_simulacion, 
+                          int flujo, int contador) {
+    uint64_t h = mezclar_bits((uint64_t)semilla);
+    h = mezclar_bits(h ^ (uint32_t)indice_simulacion);
+    h = mezclar_bits(h ^ (uint32_t)flujo);
+    h = mezclar_bits(h ^ (uint32_t)contador);
+    return (h >> 11) * (1.0 / 9007199254740992.0);  // 53 bits
+}
+
 // Genera mangos random en la caja
-void generar_mangos(EstadoSistema *estado, int num_mangos, float tamano_caja) {
-    estado->num_mangos = num_mangos;
+void generar_mangos(EstadoSistema *estado, ConfiguracionSistema *config) {
+    estado->num_mangos = config->num_mangos;
     
     // No poner los mangos muy lejos para que se puedan alcanzar
-    (void)tamano_caja;
     float limite = 7.0;  // 7cm max para que funcione bien
     
-    for (int i = 0; i < num_mangos; i++) {
-        estado->mangos[i].x = ((float)rand() / RAND_MAX) * 2.0 * limite - limite;
-        estado->mangos[i].y = ((float)rand() / RAND_MAX) * 2.0 * limite - limite;
+    for (int i = 0; i < config->num_mangos; i++) {
+        double u_x = aleatorio_contador(config->semilla, config->indice_simulacion,
+                                        FLUJO_MANGOS, 2 * i);
+        double u_y = aleatorio_contador(config->semilla, config->indice_simulacion,
+                                        FLUJO_MANGOS, 2 * i + 1);
+        estado->mangos[i].x = u_x * 2.0 * limite - limite;
+        estado->mangos[i].y = u_y * 2.0 * limite - limite;
         estado->mangos[i].etiquetado = 0;
         estado->mangos[i].robot_asignado = -1;
         estado->mangos[i].tiempo_etiquetado = -1.0;
     }
 }
 
+// Cuando falla el robot: exponencial con tasa prob_fallo (por segundo).
+// Se calcula una vez al inicio para no sortear en cada paso de la banda
+float tiempo_fallo_robot(ConfiguracionSistema *config, int robot_id) {
+    if (!config->usar_redundancia || config->prob_fallo <= 0) {
+        return INFINITY;
+    }
+    double u = aleatorio_contador(config->semilla, config->indice_simulacion,
+                                  robot_id, 0);
+    return -log(1.0 - u) / config->prob_fallo;
+}
+
 // Calcula cuanto tarda en etiquetar un mango
 float calcular_tiempo_etiquetado(Mango *mango, float tamano_caja) {
     float distancia = sqrt(mango->x * mango->x + mango->y * mango->y);
@@ -89,6 +125,254 @@ float calcular_tiempo_etiquetado(Mango *mango, float tamano_caja) {
     return (2.0 * distancia) / velocidad_robot;
 }
 
+// sem_wait/sem_post dejando la espera y el tiempo con el mutex en la traza
+static void tomar_mutex(sem_t *mutex, int robot_id) {
+    traza_evento(TRAZA_ESPERA_MUTEX, robot_id, -1);
+    sem_wait(mutex);
+    traza_evento(TRAZA_TOMA_MUTEX, robot_id, -1);
+}
+
+static void soltar_mutex(sem_t *mutex, int robot_id) {
+    traza_evento(TRAZA_SUELTA_MUTEX, robot_id, -1);
+    sem_post(mutex);
+}
+
+static double reloj_segundos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Quita el elemento j de la cola sin cambiar el orden de los demas
+static void sacar_de_cola(ColaVision *cola, int j) {
+    for (int k = j; k < cola->cantidad - 1; k++) {
+        cola->entradas[k] = cola->entradas[k + 1];
+    }
+    cola->cantidad--;
+}
+
+// La cola va en memoria anonima: la heredan la camara, la banda y los robots
+ColaVision *crear_cola_vision(ConfiguracionSistema *config) {
+    ColaVision *cola = mmap(NULL, sizeof(ColaVision), PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (cola == MAP_FAILED) {
+        perror("mmap cola de visión");
+        return NULL;
+    }
+    memset(cola, 0, sizeof(ColaVision));
+    if (sem_init(&cola->mutex, 1, 1) == -1) {
+        perror("sem_init");
+        munmap(cola, sizeof(ColaVision));
+        return NULL;
+    }
+    cola->capacidad = config->capacidad_cola;
+    cola->activa = 1;
+    cola->ultima_terminada = -1;
+    return cola;
+}
+
+void destruir_cola_vision(ColaVision *cola) {
+    sem_destroy(&cola->mutex);
+    munmap(cola, sizeof(ColaVision));
+}
+
+// Etapa de vision: toma las cajas en orden y, cuando cada una pasa por la
+// camara, detecta sus mangos uno por uno y los publica en la cola. Las
+// cajas van una detras de otra separadas por su largo, asi que la k+1
+// pasa por la camara mientras la banda todavia etiqueta la k
+void proceso_vision(ColaVision *cola, ConfiguracionSistema *config,
+                    int (*tomar_caja)(void *), void *fuente) {
+    printf("[Visión] Cámara en %.2f cm (latencia %.3fs, %.3fs/mango, "
+           "cola de %d)\n", config->posicion_camara, config->latencia_vision, 
+           config->tiempo_por_mango, config->capacidad_cola);
+    
+    EstadoSistema caja_vista;
+    ConfiguracionSistema config_caja = *config;
+    
+    for (int secuencia = 0; cola->activa; secuencia++) {
+        // No adelantarse mas de lo que se puede guardar
+        while (cola->activa && 
+               secuencia - cola->secuencia_en_banda >= MAX_CAJAS_ADELANTE) {
+            usleep(1000);
+        }
+        
+        int caja = tomar_caja(fuente);
+        int k = secuencia % MAX_CAJAS_ADELANTE;
+        
+        tomar_mutex(&cola->mutex, TRAZA_VISION);
+        if (caja < 0) {
+            cola->sin_cajas = 1;
+            soltar_mutex(&cola->mutex, TRAZA_VISION);
+            break;
+        }
+        cola->cajas[k] = caja;
+        cola->inicio_deteccion[k] = -1.0;
+        cola->fin_deteccion[k] = -1.0;
+        cola->cajas_tomadas = secuencia + 1;
+        soltar_mutex(&cola->mutex, TRAZA_VISION);
+        
+        // Esperar a que la caja llegue a la camara: va detras de la que
+        // esta en la banda, un largo de caja por cada una que le falta
+        while (cola->activa) {
+            int en_banda = cola->secuencia_en_banda;
+            float posicion = cola->posicion_banda - 
+                             (secuencia - en_banda) * config->tamano_caja;
+            if (secuencia < en_banda || posicion >= config->posicion_camara) {
+                break;
+            }
+            usleep(1000);
+        }
+        if (!cola->activa) break;
+        
+        double inicio = reloj_segundos();
+        cola->inicio_deteccion[k] = inicio;
+        usleep((int)(config->latencia_vision * 1000000));
+        
+        // Los mangos salen de la semilla y la caja, igual que en la banda
+        config_caja.indice_simulacion = caja;
+        generar_mangos(&caja_vista, &config_caja);
+        
+        int publicados = 0;
+        for (int i = 0; i < caja_vista.num_mangos; i++) {
+            usleep((int)(config->tiempo_por_mango * 1000000));
+            
+            // Si la cola esta llena hay que esperar a que los robots
+            // reclamen. Si la caja ya salio de la banda no vale la pena
+            int listo = 0;
+            while (!listo && cola->activa) {
+                tomar_mutex(&cola->mutex, TRAZA_VISION);
+                if (cola->ultima_terminada >= secuencia) {
+                    listo = -1;
+                } else if (cola->cantidad < cola->capacidad) {
+                    cola->entradas[cola->cantidad].secuencia = secuencia;
+                    cola->entradas[cola->cantidad].mango = i;
+                    cola->cantidad++;
+                    cola->mangos_publicados++;
+                    if (cola->cantidad > cola->cola_maxima) {
+                        cola->cola_maxima = cola->cantidad;
+                    }
+                    traza_evento(TRAZA_DETECCION, TRAZA_VISION, i);
+                    listo = 1;
+                }
+                soltar_mutex(&cola->mutex, TRAZA_VISION);
+                
+                if (!listo) {
+                    usleep(1000);
+                }
+            }
+            if (listo != 1) break;
+            publicados++;
+        }
+        
+        if (publicados == caja_vista.num_mangos) {
+            double fin = reloj_segundos();
+            sem_wait(&cola->mutex);
+            cola->fin_deteccion[k] = fin;
+            cola->cajas_detectadas++;
+            cola->tiempo_deteccion += fin - inicio;
+            sem_post(&cola->mutex);
+        }
+        
+        printf("[Visión] Caja %d: publicados %d / %d mangos\n", 
+               caja, publicados, caja_vista.num_mangos);
+    }
+}
+
+// Crea el proceso de la camara
+pid_t iniciar_vision(ColaVision *cola, ConfiguracionSistema *config,
+                     int (*tomar_caja)(void *), void *fuente) {
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        proceso_vision(cola, config, tomar_caja, fuente);
+        exit(0);
+    } else if (pid == -1) {
+        perror("fork");
+    }
+    return pid;
+}
+
+void detener_vision(ColaVision *cola, pid_t pid) {
+    cola->activa = 0;
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+}
+
+// La banda pide la caja numero secuencia: espera a que la camara la tome y
+// la pone en la banda. Devuelve la caja, o -1 si ya no hay
+int siguiente_caja_vision(ColaVision *cola, int secuencia) {
+    while (1) {
+        sem_wait(&cola->mutex);
+        if (cola->cajas_tomadas > secuencia) {
+            int caja = cola->cajas[secuencia % MAX_CAJAS_ADELANTE];
+            cola->secuencia_en_banda = secuencia;
+            cola->posicion_banda = 0.0;
+            cola->inicio_etiquetado = reloj_segundos();
+            sem_post(&cola->mutex);
+            return caja;
+        }
+        int sin_cajas = cola->sin_cajas || !cola->activa;
+        sem_post(&cola->mutex);
+        
+        if (sin_cajas) {
+            return -1;
+        }
+        usleep(1000);
+    }
+}
+
+// La caja salio de la banda: se tiran sus mangos que quedaron en la cola y
+// se mide cuanto de su etiquetado se cruzo con la deteccion de la siguiente
+void terminar_caja_vision(ColaVision *cola, int secuencia) {
+    double fin = reloj_segundos();
+    
+    sem_wait(&cola->mutex);
+    int quedan = 0;
+    for (int j = 0; j < cola->cantidad; j++) {
+        if (cola->entradas[j].secuencia != secuencia) {
+            cola->entradas[quedan++] = cola->entradas[j];
+        }
+    }
+    cola->cantidad = quedan;
+    cola->ultima_terminada = secuencia;
+    
+    cola->cajas_etiquetadas++;
+    cola->tiempo_etiquetado += fin - cola->inicio_etiquetado;
+    
+    int k = (secuencia + 1) % MAX_CAJAS_ADELANTE;
+    if (cola->cajas_tomadas > secuencia + 1 && cola->inicio_deteccion[k] >= 0) {
+        double desde = fmax(cola->inicio_etiquetado, cola->inicio_deteccion[k]);
+        double hasta = (cola->fin_deteccion[k] >= 0) ? 
+                       fmin(fin, cola->fin_deteccion[k]) : fin;
+        if (hasta > desde) {
+            cola->solape += hasta - desde;
+        }
+    }
+    sem_post(&cola->mutex);
+}
+
+void metricas_cola_vision(ColaVision *cola, MetricasVision *metricas) {
+    memset(metricas, 0, sizeof(MetricasVision));
+    sem_wait(&cola->mutex);
+    metricas->mangos_publicados = cola->mangos_publicados;
+    metricas->cola_maxima = cola->cola_maxima;
+    if (cola->muestras_cola > 0) {
+        metricas->cola_promedio = cola->cola_acumulada / cola->muestras_cola;
+    }
+    metricas->tiempo_deteccion = -1.0;
+    if (cola->cajas_detectadas > 0) {
+        metricas->tiempo_deteccion = cola->tiempo_deteccion / 
+                                     cola->cajas_detectadas;
+    }
+    metricas->cajas_etiquetadas = cola->cajas_etiquetadas;
+    metricas->solape = cola->solape;
+    if (cola->tiempo_etiquetado > 0) {
+        metricas->fraccion_solape = cola->solape / cola->tiempo_etiquetado;
+    }
+    sem_post(&cola->mutex);
+}
+
 // Lo que hace cada robot
 void proceso_robot(int robot_id, EstadoSistema *estado, sem_t *mutex, 
                    ConfiguracionSistema *config) {
@@ -99,6 +383,10 @@ void proceso_robot(int robot_id, EstadoSistema *estado, sem_t *mutex,
     printf("[Robot %d] Iniciado en posición %.2f cm (zona: %.2f - %.2f)\n", 
            robot_id, pos_robot, inicio_zona, fin_zona);
     
+    // Para la traza: solo el primer rechazo de cada mango por visita
+    int en_zona = 0;
+    int rechazo_reportado[MAX_MANGOS] = {0};
+    
     while (estado->simulacion_activa) {
         if (estado->robots_fallados[robot_id]) {
             usleep(100000);
@@ -107,15 +395,43 @@ void proceso_robot(int robot_id, EstadoSistema *estado, sem_t *mutex,
         
         float pos_caja = estado->posicion_caja;
         
+        int dentro = (pos_caja >= inicio_zona && pos_caja <= fin_zona);
+        if (dentro != en_zona) {
+            traza_evento(dentro ? TRAZA_ENTRA_ZONA : TRAZA_SALE_ZONA, 
+                         robot_id, -1);
+            if (dentro) {
+                memset(rechazo_reportado, 0, sizeof(rechazo_reportado));
+            }
+            en_zona = dentro;
+        }
+        
         // Si la caja esta en mi zona, buscar mangos
-        if (pos_caja >= inicio_zona && pos_caja <= fin_zona) {
-            sem_wait(mutex);
+        if (dentro) {
+            tomar_mutex(mutex, robot_id);
             
             int mango_etiquetado_ahora = 0;
             float tiempo_actual = pos_caja / config->velocidad_banda;
             
+            // Con vision solo se conocen los mangos de esta caja que ya
+            // estan en la cola (siempre despues del mutex del estado)
+            ColaVision *cola = config->usar_vision ? config->cola_vision : NULL;
+            int cola_tomada = 0;
+            if (cola != NULL) {
+                sem_wait(&cola->mutex);
+                cola_tomada = 1;
+            }
+            int num_candidatos = cola_tomada ? cola->cantidad : 
+                                               estado->num_mangos;
+            
             // Buscar un mango que no este etiquetado
-            for (int i = 0; i < estado->num_mangos; i++) {
+            for (int j = 0; j < num_candidatos; j++) {
+                int i = j;
+                if (cola_tomada) {
+                    if (cola->entradas[j].secuencia != config->secuencia_caja) {
+                        continue;
+                    }
+                    i = cola->entradas[j].mango;
+                }
                 if (!estado->mangos[i].etiquetado && 
                     estado->mangos[i].robot_asignado == -1) {
                     
@@ -128,10 +444,19 @@ void proceso_robot(int robot_id, EstadoSistema *estado, sem_t *mutex,
                     if (tiempo_etiquetado <= tiempo_disponible) {
                         estado->mangos[i].robot_asignado = robot_id;
                         mango_etiquetado_ahora = 1;
+                        traza_evento(TRAZA_RECLAMO, robot_id, i);
                         
-                        sem_post(mutex);
+                        if (cola_tomada) {
+                            sacar_de_cola(cola, j);
+                            sem_post(&cola->mutex);
+                            cola_tomada = 0;
+                        }
+                        
+                        soltar_mutex(mutex, robot_id);
+                        traza_evento(TRAZA_INICIO_ETIQUETA, robot_id, i);
                         usleep((int)(tiempo_etiquetado * 1000000));
-                        sem_wait(mutex);
+                        traza_evento(TRAZA_FIN_ETIQUETA, robot_id, i);
+                        tomar_mutex(mutex, robot_id);
                         
                         estado->mangos[i].etiquetado = 1;
                         estado->mangos[i].tiempo_etiquetado = tiempo_actual + 
@@ -143,15 +468,22 @@ void proceso_robot(int robot_id, EstadoSistema *estado, sem_t *mutex,
                                estado->mangos[i].y, tiempo_etiquetado);
                         
                         break;  // Ya etiquete uno, buscar otro
+                    } else if (!rechazo_reportado[i]) {
+                        traza_evento(TRAZA_RECHAZO, robot_id, i);
+                        rechazo_reportado[i] = 1;
                     }
                 }
             }
             
+            if (cola_tomada) {
+                sem_post(&cola->mutex);
+            }
+            
             // Soltar el mutex
             if (mango_etiquetado_ahora) {
-                sem_post(mutex);
+                soltar_mutex(mutex, robot_id);
             } else {
-                sem_post(mutex);
+                soltar_mutex(mutex, robot_id);
                 // No hay mangos, esperar
                 usleep(10000);
             }
@@ -162,7 +494,7 @@ void proceso_robot(int robot_id, EstadoSistema *estado, sem_t *mutex,
         
         // Ver si ya terminamos
         if (pos_caja > fin_zona) {
-            sem_wait(mutex);
+            tomar_mutex(mutex, robot_id);
             int todos_etiquetados = 1;
             for (int i = 0; i < estado->num_mangos; i++) {
                 if (!estado->mangos[i].etiquetado) {
@@ -172,31 +504,107 @@ void proceso_robot(int robot_id, EstadoSistema *estado, sem_t *mutex,
             }
             if (todos_etiquetados) {
                 estado->caja_completada = 1;
-                sem_post(mutex);
+                soltar_mutex(mutex, robot_id);
                 break;
             }
-            sem_post(mutex);
+            soltar_mutex(mutex, robot_id);
         }
         
         usleep(1000);  // Dormir un poco
     }
     
+    if (en_zona) {
+        traza_evento(TRAZA_SALE_ZONA, robot_id, -1);
+    }
+    
     printf("[Robot %d] Finalizando operación\n", robot_id);
 }
 
+// Copia las metricas de vision de la ultima simulacion
+void obtener_metricas_vision(MetricasVision *metricas) {
+    *metricas = ultimas_metricas_vision;
+}
+
+// Fuente de una sola caja para la camara
+static int tomar_una_caja(void *fuente) {
+    int *caja = fuente;
+    int tomada = *caja;
+    *caja = -1;
+    return tomada;
+}
+
+// Vision sin linea (simulador, analisis): la camara vive solo para esta caja
+static int simular_caja_con_vision(ConfiguracionSistema *config, 
+                                   int *mangos_etiquetados) {
+    ColaVision *cola = crear_cola_vision(config);
+    if (cola == NULL) {
+        return -1;
+    }
+    
+    int caja = config->indice_simulacion;
+    pid_t pid = iniciar_vision(cola, config, tomar_una_caja, &caja);
+    if (pid == -1) {
+        destruir_cola_vision(cola);
+        return -1;
+    }
+    
+    ConfiguracionSistema config_caja = *config;
+    config_caja.cola_vision = cola;
+    config_caja.secuencia_caja = 0;
+    
+    int exito = -1;
+    if (siguiente_caja_vision(cola, 0) >= 0) {
+        exito = simular_etiquetado(&config_caja, mangos_etiquetados);
+        terminar_caja_vision(cola, 0);
+    }
+    detener_vision(cola, pid);
+    
+    MetricasVision *m = &ultimas_metricas_vision;
+    metricas_cola_vision(cola, m);
+    destruir_cola_vision(cola);
+    
+    printf("Visión: %d publicados | Cola promedio: %.2f | Cola máxima: %d",
+           m->mangos_publicados, m->cola_promedio, m->cola_maxima);
+    if (m->tiempo_deteccion >= 0) {
+        printf(" | Detección completa en %.2fs", m->tiempo_deteccion);
+    }
+    printf("\n");
+    
+    return exito;
+}
+
 // Corre toda la simulacion
 int simular_etiquetado(ConfiguracionSistema *config, int *mangos_etiquetados) {
     pid_t pids[MAX_ROBOTS];
     int num_procesos = 0;
     
-    shm_fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0666);
+    if (config->usar_vision && config->cola_vision == NULL) {
+        return simular_caja_con_vision(config, mangos_etiquetados);
+    }
+    
+    // Los nombres llevan el pid del proceso que simula (cada linea, cada
+    // trabajador del planificador, el simulador suelto) ademas de la linea,
+    // asi dos corridas a la vez nunca comparten memoria ni mutex
+    snprintf(nombre_shm, sizeof(nombre_shm), "%s_%d_%d", SHM_NAME,
+             (int)getpid(), config->id_linea);
+    snprintf(nombre_mutex, sizeof(nombre_mutex), "%s_%d_%d", SEM_MUTEX_NAME,
+             (int)getpid(), config->id_linea);
+    
+    // O_EXCL: si el nombre ya existe es basura de otra corrida, no se reusa
+    shm_fd = shm_open(nombre_shm, O_CREAT | O_EXCL | O_RDWR, 0666);
     if (shm_fd == -1) {
-        perror("shm_open");
+        if (errno == EEXIST) {
+            fprintf(stderr, "Error: %s ya existe (corre 'make clean-ipc')\n",
+                    nombre_shm);
+        } else {
+            perror("shm_open");
+        }
         return -1;
     }
     
     if (ftruncate(shm_fd, sizeof(EstadoSistema)) == -1) {
         perror("ftruncate");
+        cleanup_recursos();
         return -1;
     }
     
@@ -204,17 +612,35 @@ int simular_etiquetado(ConfiguracionSistema *config, int *mangos_etiquetados) {
                              PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
     if (estado_compartido == MAP_FAILED) {
         perror("mmap");
+        estado_compartido = NULL;
+        cleanup_recursos();
         return -1;
     }
     
-    sem_mutex = sem_open(SEM_MUTEX_NAME, O_CREAT, 0666, 1);
+    sem_mutex = sem_open(nombre_mutex, O_CREAT | O_EXCL, 0666, 1);
     if (sem_mutex == SEM_FAILED) {
-        perror("sem_open");
+        if (errno == EEXIST) {
+            fprintf(stderr, "Error: %s ya existe (corre 'make clean-ipc')\n",
+                    nombre_mutex);
+        } else {
+            perror("sem_open");
+        }
+        sem_mutex = NULL;
+        cleanup_recursos();
         return -1;
     }
     
     inicializar_sistema(estado_compartido, config);
-    generar_mangos(estado_compartido, config->num_mangos, config->tamano_caja);
+    generar_mangos(estado_compartido, config);
+    
+    float tiempos_fallo[MAX_ROBOTS];
+    for (int i = 0; i < config->num_robots; i++) {
+        tiempos_fallo[i] = tiempo_fallo_robot(config, i);
+    }
+    
+    // Vaciar stdout y los CSV abiertos para que los hijos no repitan lo que
+    // quedo en el buffer al salir
+    fflush(NULL);
     
     // Crear los procesos de los robots
     for (int i = 0; i < config->num_robots; i++) {
@@ -238,22 +664,33 @@ int simular_etiquetado(ConfiguracionSistema *config, int *mangos_etiquetados) {
     
     for (int paso = 0; paso <= pasos && estado_compartido->simulacion_activa; 
          paso++) {
-        sem_wait(sem_mutex);
+        tomar_mutex(sem_mutex, TRAZA_BANDA);
         estado_compartido->posicion_caja += config->velocidad_banda * dt;
         
         if (config->usar_redundancia && config->prob_fallo > 0) {
+            float tiempo = (paso + 1) * dt;
             for (int i = 0; i < config->num_robots; i++) {
-                if (!estado_compartido->robots_fallados[i]) {
-                    if ((float)rand() / RAND_MAX < config->prob_fallo * dt) {
-                        estado_compartido->robots_fallados[i] = 1;
-                        printf("[SISTEMA] Robot %d ha fallado!\n", i);
-                    }
+                if (!estado_compartido->robots_fallados[i] && 
+                    tiempo >= tiempos_fallo[i]) {
+                    estado_compartido->robots_fallados[i] = 1;
+                    traza_evento(TRAZA_FALLO, i, -1);
+                    printf("[SISTEMA] Robot %d ha fallado!\n", i);
                 }
             }
         }
         
+        // La camara sabe por aqui donde va la caja
+        if (config->usar_vision) {
+            ColaVision *cola = config->cola_vision;
+            sem_wait(&cola->mutex);
+            cola->posicion_banda = estado_compartido->posicion_caja;
+            cola->cola_acumulada += cola->cantidad;
+            cola->muestras_cola++;
+            sem_post(&cola->mutex);
+        }
+        
         int completada = estado_compartido->caja_completada;
-        sem_post(sem_mutex);
+        soltar_mutex(sem_mutex, TRAZA_BANDA);
         
         if (completada) {
             break;
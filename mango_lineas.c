@@ -0,0 +1,450 @@
+#define _GNU_SOURCE  // para sched_setaffinity
+#include "mango_system.h"
+#include <sched.h>
+
+// Resultados de cada linea
+typedef struct {
+    char cpus[32];      // afinidad real de la linea, como "0-1,4"
+    int num_cpus;
+    int fijada;         // 1 si sched_setaffinity funciono
+    int cajas_procesadas;
+    int cajas_exitosas;
+    int mangos_etiquetados;
+    int mangos_totales;
+    double tiempo_total;
+    MetricasVision vision;  // solo con la etapa de vision
+} ResultadoLinea;
+
+// Reparte las cajas entre las lineas (va en memoria compartida)
+typedef struct {
+    sem_t mutex;
+    int cajas_totales;
+    int siguiente_caja;
+    ResultadoLinea lineas[MAX_LINEAS];
+} Despachador;
+
+static double tiempo_actual() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Escribe la afinidad actual del proceso como lista de rangos ("0-1,4")
+static void describir_afinidad(ResultadoLinea *resultado) {
+    cpu_set_t cpus;
+    resultado->cpus[0] = '\0';
+    resultado->num_cpus = 0;
+
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) == -1) {
+        perror("sched_getaffinity");
+        snprintf(resultado->cpus, sizeof(resultado->cpus), "?");
+        return;
+    }
+
+    size_t usado = 0;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (!CPU_ISSET(c, &cpus)) continue;
+
+        int fin = c;
+        while (fin + 1 < CPU_SETSIZE && CPU_ISSET(fin + 1, &cpus)) fin++;
+        resultado->num_cpus += fin - c + 1;
+
+        if (usado < sizeof(resultado->cpus)) {
+            int n = (fin > c) ?
+                snprintf(resultado->cpus + usado, sizeof(resultado->cpus) - usado,
+                         "%s%d-%d", usado ? "," : "", c, fin) :
+                snprintf(resultado->cpus + usado, sizeof(resultado->cpus) - usado,
+                         "%s%d", usado ? "," : "", c);
+            usado += n;
+        }
+        c = fin;
+    }
+}
+
+// Fija la linea (y sus robots, que heredan la afinidad) a su parte de los
+// cores que el proceso tiene permitidos, que con taskset o cgroups pueden
+// ser menos que los del equipo. El resultado guarda la afinidad que quedo
+// de verdad, se haya podido fijar o no
+void fijar_cpus_linea(int linea, int num_lineas, ResultadoLinea *resultado) {
+    cpu_set_t permitidas;
+    int lista[CPU_SETSIZE];
+    int total_cpus = 0;
+
+    if (sched_getaffinity(0, sizeof(permitidas), &permitidas) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &permitidas)) {
+                lista[total_cpus++] = c;
+            }
+        }
+    } else {
+        perror("sched_getaffinity");
+    }
+
+    resultado->fijada = 0;
+    if (total_cpus > 0) {
+        int cpus_por_linea = total_cpus / num_lineas;
+        if (cpus_por_linea < 1) cpus_por_linea = 1;
+
+        // Si hay mas lineas que cores, algunas comparten
+        int primera = (linea * cpus_por_linea) % total_cpus;
+
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int c = 0; c < cpus_por_linea; c++) {
+            CPU_SET(lista[(primera + c) % total_cpus], &cpus);
+        }
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) == 0) {
+            resultado->fijada = 1;
+        } else {
+            perror("sched_setaffinity");
+        }
+    }
+
+    describir_afinidad(resultado);
+}
+
+// Siguiente caja del despachador, -1 si ya se repartieron todas
+static int tomar_caja_despachador(void *fuente) {
+    Despachador *despachador = fuente;
+    sem_wait(&despachador->mutex);
+    int caja = despachador->siguiente_caja++;
+    sem_post(&despachador->mutex);
+    return (caja < despachador->cajas_totales) ? caja : -1;
+}
+
+// Lo que hace cada linea: pedir cajas al despachador hasta que no queden.
+// Con vision las pide la camara de la linea, que va una caja adelante, y
+// la banda etiqueta las que la camara ya tomo
+void proceso_linea(int linea, int num_lineas, Despachador *despachador,
+                   ConfiguracionSistema *config_base, int verboso) {
+    ResultadoLinea *resultado = &despachador->lineas[linea];
+    fijar_cpus_linea(linea, num_lineas, resultado);
+
+    ConfiguracionSistema config = *config_base;
+    config.id_linea = linea;
+
+    // Los mensajes de los robots tapan el reporte
+    if (!verboso) {
+        if (freopen("/dev/null", "w", stdout) == NULL) {
+            perror("freopen");
+        }
+    }
+
+    // Con MANGO_TRAZA cada linea tiene su buffer y guarda una sola traza al
+    // final. No se vacia entre cajas porque la camara sigue escribiendo
+    // mientras detecta la caja siguiente
+    const char *ruta_traza = getenv("MANGO_TRAZA");
+    if (ruta_traza != NULL && traza_iniciar(TRAZA_CAPACIDAD) == -1) {
+        ruta_traza = NULL;
+    }
+
+    ColaVision *cola = NULL;
+    pid_t pid_vision = -1;
+    if (config.usar_vision) {
+        cola = crear_cola_vision(&config);
+        if (cola != NULL) {
+            pid_vision = iniciar_vision(cola, &config, tomar_caja_despachador,
+                                        despachador);
+        }
+        if (pid_vision == -1) {
+            fprintf(stderr, "[Línea %d] No se pudo iniciar la visión\n", linea);
+            if (cola != NULL) destruir_cola_vision(cola);
+            return;
+        }
+    }
+    config.cola_vision = cola;
+
+    double inicio = tiempo_actual();
+
+    for (int secuencia = 0; ; secuencia++) {
+        int caja = (cola != NULL) ? siguiente_caja_vision(cola, secuencia) :
+                                    tomar_caja_despachador(despachador);
+        if (caja < 0) {
+            break;
+        }
+
+        // Los mangos dependen de la caja, no de la linea que la toma
+        config.indice_simulacion = caja;
+        config.secuencia_caja = secuencia;
+
+        int mangos_etiquetados = 0;
+        traza_evento(TRAZA_INICIO_CAJA, TRAZA_BANDA, caja);
+        int exito = simular_etiquetado(&config, &mangos_etiquetados);
+        if (cola != NULL) {
+            terminar_caja_vision(cola, secuencia);
+        }
+        if (exito < 0) {
+            fprintf(stderr, "[Línea %d] Error simulando caja %d\n", linea, caja);
+            break;
+        }
+
+        resultado->cajas_procesadas++;
+        resultado->cajas_exitosas += exito;
+        resultado->mangos_etiquetados += mangos_etiquetados;
+        resultado->mangos_totales += config.num_mangos;
+
+        fprintf(stderr, "[Línea %d] Caja %d: %d/%d etiquetados\n",
+                linea, caja, mangos_etiquetados, config.num_mangos);
+    }
+
+    resultado->tiempo_total = tiempo_actual() - inicio;
+
+    if (cola != NULL) {
+        detener_vision(cola, pid_vision);
+        metricas_cola_vision(cola, &resultado->vision);
+        destruir_cola_vision(cola);
+    }
+
+    // La camara ya termino, nadie mas escribe en el buffer
+    if (ruta_traza != NULL) {
+        char sufijo[32], ruta[256];
+        snprintf(sufijo, sizeof(sufijo), "_linea%d", linea);
+        traza_ruta(ruta, sizeof(ruta), ruta_traza, sufijo);
+        traza_exportar_chrome(ruta, config.num_robots);
+    }
+    traza_liberar();
+}
+
+// Imprime la tabla por linea y el total, y la guarda en CSV
+void reportar_lineas(Despachador *despachador, int num_lineas,
+                     double tiempo_total, int usar_vision) {
+    printf("\n=== RESULTADOS POR LÍNEA ===\n");
+    printf("Línea | CPUs         | Cajas | Éxitos | Mangos    | Tiempo  | Cajas/min\n");
+    printf("------|--------------|-------|--------|-----------|---------|----------\n");
+
+    FILE *archivo = fopen("analisis_lineas.csv", "w");
+    if (archivo == NULL) {
+        perror("Error abriendo archivo");
+    } else {
+        fprintf(archivo, "Linea,CPUs,NumCPUs,Fijada,Cajas,CajasExitosas,"
+                "MangosEtiquetados,MangosTotales,Tiempo,CajasPorMinuto,"
+                "ColaPromedio,ColaMaxima,DeteccionPorCaja,Solape,FraccionSolape\n");
+    }
+
+    int cajas = 0, exitosas = 0, etiquetados = 0, mangos = 0;
+    int sin_fijar = 0;
+
+    for (int l = 0; l < num_lineas; l++) {
+        ResultadoLinea *r = &despachador->lineas[l];
+        double cajas_min = (r->tiempo_total > 0) ?
+                           r->cajas_procesadas * 60.0 / r->tiempo_total : 0.0;
+
+        // Sin fijar la linea corre donde la deje el sistema
+        printf("%5d | %-9s%-3s | %5d | %6d | %4d/%-4d | %6.2fs | %9.2f\n",
+               l, r->cpus, r->fijada ? "" : " *",
+               r->cajas_procesadas, r->cajas_exitosas,
+               r->mangos_etiquetados, r->mangos_totales,
+               r->tiempo_total, cajas_min);
+
+        if (archivo != NULL) {
+            fprintf(archivo, "%d,\"%s\",%d,%d,%d,%d,%d,%d,%.3f,%.3f,"
+                    "%.3f,%d,%.3f,%.3f,%.3f\n",
+                    l, r->cpus, r->num_cpus, r->fijada, r->cajas_procesadas,
+                    r->cajas_exitosas, r->mangos_etiquetados,
+                    r->mangos_totales, r->tiempo_total, cajas_min,
+                    r->vision.cola_promedio, r->vision.cola_maxima,
+                    r->vision.tiempo_deteccion, r->vision.solape,
+                    r->vision.fraccion_solape);
+        }
+
+        cajas += r->cajas_procesadas;
+        exitosas += r->cajas_exitosas;
+        etiquetados += r->mangos_etiquetados;
+        mangos += r->mangos_totales;
+        sin_fijar += !r->fijada;
+    }
+
+    if (sin_fijar > 0) {
+        printf("* No se pudo fijar la afinidad, se muestran los CPUs heredados\n");
+    }
+
+    // Solape: tiempo que la camara estuvo detectando la caja siguiente
+    // mientras la banda etiquetaba la actual
+    if (usar_vision) {
+        printf("\n=== ETAPA DE VISIÓN ===\n");
+        printf("Línea | Publicados | Cola prom | Cola máx | Detección/caja | Solape\n");
+        printf("------|------------|-----------|----------|----------------|----------------\n");
+        for (int l = 0; l < num_lineas; l++) {
+            MetricasVision *v = &despachador->lineas[l].vision;
+            printf("%5d | %10d | %9.2f | %8d | %13.2fs | %6.2fs (%3.0f%%)\n",
+                   l, v->mangos_publicados, v->cola_promedio, v->cola_maxima,
+                   v->tiempo_deteccion, v->solape, v->fraccion_solape * 100);
+        }
+    }
+
+    if (archivo != NULL) {
+        fclose(archivo);
+    }
+
+    printf("\n=== TOTAL ===\n");
+    printf("Cajas procesadas: %d (%d exitosas)\n", cajas, exitosas);
+    printf("Mangos etiquetados: %d / %d\n", etiquetados, mangos);
+    printf("Tiempo total: %.2fs\n", tiempo_total);
+    if (tiempo_total > 0) {
+        printf("Throughput: %.2f cajas/min | %.2f mangos/s\n",
+               cajas * 60.0 / tiempo_total, etiquetados / tiempo_total);
+    }
+    printf("\nResultados guardados en: analisis_lineas.csv\n");
+}
+
+int main(int argc, char *argv[]) {
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    if (argc < 3) {
+        printf("Uso: %s <num_lineas> <num_cajas> [velocidad_banda] [tamano_caja] "
+               "[longitud_banda] [robots_por_linea] [mangos_por_caja] [verboso] "
+               "[semilla] [latencia_vision] [tiempo_por_mango] [capacidad_cola] "
+               "[posicion_camara]\n",
+               argv[0]);
+        printf("\nEjemplo:\n");
+        printf("  %s 4 20 10 50 200 4 6   # 4 líneas, 20 cajas repartidas\n",
+               argv[0]);
+        printf("  %s 2 6 10 50 200 6 10 0 7 0.5 0.1 5   # con visión\n",
+               argv[0]);
+        return 1;
+    }
+
+    int num_lineas = atoi(argv[1]);
+    int num_cajas = atoi(argv[2]);
+
+    ConfiguracionSistema config;
+    config.velocidad_banda = (argc >= 4) ? atof(argv[3]) : 10.0;
+    config.tamano_caja = (argc >= 5) ? atof(argv[4]) : 50.0;
+    config.longitud_banda = (argc >= 6) ? atof(argv[5]) : 200.0;
+    config.num_robots = (argc >= 7) ? atoi(argv[6]) : 4;
+    config.num_mangos = (argc >= 8) ? atoi(argv[7]) : 6;
+    config.prob_fallo = 0.0;
+    config.usar_redundancia = 0;
+    config.id_linea = 0;
+    config.semilla = (argc >= 10) ? strtoul(argv[9], NULL, 10) :
+                                    (unsigned long)time(NULL);
+    config.indice_simulacion = 0;
+    config.usar_vision = (argc >= 11);
+    config.posicion_camara = (argc >= 14) ? atof(argv[13]) : 0.0;
+    config.latencia_vision = (argc >= 11) ? atof(argv[10]) : 0.0;
+    config.tiempo_por_mango = (argc >= 12) ? atof(argv[11]) : 0.0;
+    config.capacidad_cola = (argc >= 13) ? atoi(argv[12]) : MAX_MANGOS;
+    config.cola_vision = NULL;
+    config.secuencia_caja = 0;
+    int verboso = (argc >= 9) ? atoi(argv[8]) : 0;
+
+    // Validar parametros
+    if (num_lineas <= 0 || num_lineas > MAX_LINEAS) {
+        printf("Error: Número de líneas debe estar entre 1 y %d\n", MAX_LINEAS);
+        return 2;
+    }
+    if (num_cajas <= 0) {
+        printf("Error: Número de cajas debe ser positivo\n");
+        return 2;
+    }
+    if (config.velocidad_banda <= 0 || config.tamano_caja <= 0 ||
+        config.longitud_banda <= 0 || config.num_robots <= 0 ||
+        config.num_mangos <= 0) {
+        printf("Error: Todos los parámetros deben ser positivos\n");
+        return 2;
+    }
+    if (config.num_robots > MAX_ROBOTS) {
+        printf("Error: Máximo %d robots permitidos\n", MAX_ROBOTS);
+        return 2;
+    }
+    if (config.num_mangos > MAX_MANGOS) {
+        printf("Error: Máximo %d mangos permitidos\n", MAX_MANGOS);
+        return 2;
+    }
+    if (config.latencia_vision < 0 || config.tiempo_por_mango < 0) {
+        printf("Error: Tiempos de visión no pueden ser negativos\n");
+        return 2;
+    }
+    if (config.capacidad_cola <= 0 || config.capacidad_cola > MAX_MANGOS) {
+        printf("Error: Capacidad de cola debe estar entre 1 y %d\n", MAX_MANGOS);
+        return 2;
+    }
+    if (!(config.posicion_camara >= 0 &&
+          config.posicion_camara <= config.longitud_banda)) {
+        printf("Error: La cámara debe estar entre 0 y %.2f cm (la banda)\n",
+               config.longitud_banda);
+        return 2;
+    }
+
+    // El despachador solo lo comparten los hijos, no necesita nombre
+    Despachador *despachador = mmap(NULL, sizeof(Despachador),
+                                    PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (despachador == MAP_FAILED) {
+        perror("mmap");
+        return 2;
+    }
+    memset(despachador, 0, sizeof(Despachador));
+    despachador->cajas_totales = num_cajas;
+    if (sem_init(&despachador->mutex, 1, 1) == -1) {
+        perror("sem_init");
+        munmap(despachador, sizeof(Despachador));
+        return 2;
+    }
+
+    printf("\n=== INICIANDO COORDINADOR MULTI-LÍNEA ===\n");
+    printf("Líneas: %d | Cajas: %d | Robots/línea: %d | Mangos/caja: %d\n",
+           num_lineas, num_cajas, config.num_robots, config.num_mangos);
+    printf("Velocidad: %.2f cm/s | Caja: %.2f cm | Banda: %.2f cm\n",
+           config.velocidad_banda, config.tamano_caja, config.longitud_banda);
+    printf("Semilla: %lu\n", config.semilla);
+    if (config.usar_vision) {
+        printf("Visión: cámara en %.2f cm | latencia %.3fs | %.3fs por mango | "
+               "cola de %d por línea\n", config.posicion_camara,
+               config.latencia_vision, config.tiempo_por_mango,
+               config.capacidad_cola);
+    }
+    if (getenv("MANGO_TRAZA") != NULL) {
+        printf("Traza: una por línea, %s con _lineaL\n", getenv("MANGO_TRAZA"));
+    }
+    printf("\n");
+    fflush(stdout);
+
+    double inicio = tiempo_actual();
+
+    pid_t pids[MAX_LINEAS];
+    int num_procesos = 0;
+
+    // Crear un proceso por linea
+    for (int l = 0; l < num_lineas; l++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            proceso_linea(l, num_lineas, despachador, &config, verboso);
+            exit(0);
+        } else if (pid > 0) {
+            pids[num_procesos++] = pid;
+        } else {
+            perror("fork");
+            break;
+        }
+    }
+
+    for (int i = 0; i < num_procesos; i++) {
+        waitpid(pids[i], NULL, 0);
+    }
+
+    double tiempo_total = tiempo_actual() - inicio;
+
+    reportar_lineas(despachador, num_lineas, tiempo_total, config.usar_vision);
+
+    int cajas = 0, exitosas = 0;
+    for (int l = 0; l < num_lineas; l++) {
+        cajas += despachador->lineas[l].cajas_procesadas;
+        exitosas += despachador->lineas[l].cajas_exitosas;
+    }
+
+    sem_destroy(&despachador->mutex);
+    munmap(despachador, sizeof(Despachador));
+
+    if (cajas < num_cajas) {
+        printf("\n✗ ERROR: Solo se procesaron %d de %d cajas\n", cajas, num_cajas);
+        return 2;
+    }
+    if (exitosas == cajas) {
+        printf("\n✓ ÉXITO: Todas las cajas fueron etiquetadas\n");
+        return 0;
+    }
+    printf("\n✗ FALLO: %d cajas no fueron etiquetadas\n", cajas - exitosas);
+    return 1;
+}
@@ -4,8 +4,6 @@ int main(int argc, char *argv[]) {
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
     
-    srand(time(NULL));
-    
     ConfiguracionSistema config;
     
     // Leer parametros o usar defaults
@@ -17,6 +15,17 @@ int main(int argc, char *argv[]) {
         config.num_mangos = (argc >= 6) ? atoi(argv[5]) : 20;
         config.prob_fallo = (argc >= 7) ? atof(argv[6]) : 0.0;
         config.usar_redundancia = (argc >= 8) ? atoi(argv[7]) : 0;
+        config.id_linea = 0;
+        config.semilla = (argc >= 9) ? strtoul(argv[8], NULL, 10) : 
+                                       (unsigned long)time(NULL);
+        config.indice_simulacion = 0;
+        config.usar_vision = (argc >= 10);
+        config.posicion_camara = (argc >= 13) ? atof(argv[12]) : 0.0;
+        config.latencia_vision = (argc >= 10) ? atof(argv[9]) : 0.0;
+        config.tiempo_por_mango = (argc >= 11) ? atof(argv[10]) : 0.0;
+        config.capacidad_cola = (argc >= 12) ? atoi(argv[11]) : MAX_MANGOS;
+        config.cola_vision = NULL;
+        config.secuencia_caja = 0;
         
         // Validar parametros
         if (config.velocidad_banda <= 0 || config.tamano_caja <= 0 || 
@@ -29,6 +38,21 @@ int main(int argc, char *argv[]) {
             printf("Error: Probabilidad de fallo debe estar entre 0 y 1\n");
             return 2;
         }
+        if (config.latencia_vision < 0 || config.tiempo_por_mango < 0) {
+            printf("Error: Tiempos de visión no pueden ser negativos\n");
+            return 2;
+        }
+        if (config.capacidad_cola <= 0 || config.capacidad_cola > MAX_MANGOS) {
+            printf("Error: Capacidad de cola debe estar entre 1 y %d\n", 
+                   MAX_MANGOS);
+            return 2;
+        }
+        if (!(config.posicion_camara >= 0 && 
+              config.posicion_camara <= config.longitud_banda)) {
+            printf("Error: La cámara debe estar entre 0 y %.2f cm (la banda)\n",
+                   config.longitud_banda);
+            return 2;
+        }
         if (config.num_robots > MAX_ROBOTS) {
             printf("Error: Máximo %d robots permitidos\n", MAX_ROBOTS);
             return 2;
@@ -46,21 +70,51 @@ int main(int argc, char *argv[]) {
         config.num_mangos = 20;
         config.prob_fallo = 0.0;
         config.usar_redundancia = 0;
+        config.id_linea = 0;
+        config.semilla = (unsigned long)time(NULL);
+        config.indice_simulacion = 0;
+        config.usar_vision = 0;
+        config.posicion_camara = 0.0;
+        config.latencia_vision = 0.0;
+        config.tiempo_por_mango = 0.0;
+        config.capacidad_cola = MAX_MANGOS;
+        config.cola_vision = NULL;
+        config.secuencia_caja = 0;
         
         printf("Uso: %s <velocidad_banda> <tamano_caja> <longitud_banda> "
-               "<num_robots> [num_mangos] [prob_fallo] [usar_redundancia]\n", 
+               "<num_robots> [num_mangos] [prob_fallo] [usar_redundancia] "
+               "[semilla] [latencia_vision] [tiempo_por_mango] [capacidad_cola] "
+               "[posicion_camara]\n", 
                argv[0]);
         printf("Usando configuración por defecto...\n\n");
     }
     
     printf("\n=== INICIANDO SIMULACIÓN ===\n");
-    printf("Mangos: %d | Robots: %d | Velocidad: %.2f cm/s | Caja: %.2f cm\n\n",
+    printf("Mangos: %d | Robots: %d | Velocidad: %.2f cm/s | Caja: %.2f cm\n",
            config.num_mangos, config.num_robots, config.velocidad_banda, 
            config.tamano_caja);
+    printf("Semilla: %lu\n", config.semilla);
+    if (config.usar_vision) {
+        printf("Visión: cámara en %.2f cm | latencia %.3fs | %.3fs por mango | "
+               "cola de %d\n", config.posicion_camara, config.latencia_vision, 
+               config.tiempo_por_mango, config.capacidad_cola);
+    }
+    printf("\n");
+    
+    // Traza opcional: MANGO_TRAZA=archivo.json ./mango_simulator ...
+    const char *ruta_traza = getenv("MANGO_TRAZA");
+    if (ruta_traza != NULL && traza_iniciar(TRAZA_CAPACIDAD) == -1) {
+        ruta_traza = NULL;
+    }
     
     int mangos_etiquetados;
     int resultado = simular_etiquetado(&config, &mangos_etiquetados);
     
+    if (ruta_traza != NULL) {
+        traza_exportar_chrome(ruta_traza, config.num_robots);
+        traza_liberar();
+    }
+    
     if (resultado == 1) {
         printf("\n✓ ÉXITO: Todos los mangos fueron etiquetados\n");
         return 0;
@@ -0,0 +1,338 @@
+#include "mango_system.h"
+
+#define TABLA_POR_DEFECTO "tabla_robots.bin"
+#define MAX_PROCESOS_BARRIDO MAX_LINEAS
+
+static double tiempo_actual() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t puntos_eje(float minimo, float maximo, float paso) {
+    return (uint32_t)floorf((maximo - minimo) / paso + 1e-3f) + 1;
+}
+
+// Prueba una configuracion; corta apenas ya no se puede llegar al objetivo
+static int cumple_objetivo(ConfiguracionSistema *config, int num_simulaciones,
+                           float tasa_exito_objetivo) {
+    int fallos_permitidos = (int)floorf(num_simulaciones *
+                                        (1.0f - tasa_exito_objetivo) + 1e-4f);
+    int fallos = 0;
+
+    for (int s = 0; s < num_simulaciones; s++) {
+        int mangos_etiquetados;
+        config->indice_simulacion = s;
+        if (simular_etiquetado(config, &mangos_etiquetados) != 1) {
+            fallos++;
+            if (fallos > fallos_permitidos) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Un proceso del barrido: se queda con las combinaciones (velocidad, caja)
+// que le tocan y recorre los mangos de menor a mayor. Como mas mangos nunca
+// necesitan menos robots, cada busqueda empieza donde termino la anterior
+static void proceso_barrido(int proceso, int num_procesos,
+                            const CabeceraTabla *cabecera,
+                            ConfiguracionSistema *config_base,
+                            uint8_t *robots) {
+    ConfiguracionSistema config = *config_base;
+    config.id_linea = proceso;  // los nombres IPC ya llevan el pid del trabajador
+
+    uint32_t combinaciones = cabecera->n_velocidad * cabecera->n_caja;
+
+    for (uint32_t k = proceso; k < combinaciones; k += num_procesos) {
+        uint32_t iv = k / cabecera->n_caja;
+        uint32_t ic = k % cabecera->n_caja;
+        config.velocidad_banda = cabecera->velocidad_min +
+                                 iv * cabecera->velocidad_paso;
+        config.tamano_caja = cabecera->caja_min + ic * cabecera->caja_paso;
+
+        int robots_desde = 1;
+
+        for (uint32_t im = 0; im < cabecera->n_mangos; im++) {
+            config.num_mangos = (int)lroundf(cabecera->mangos_min +
+                                             im * cabecera->mangos_paso);
+            int encontrado = TABLA_SIN_SOLUCION;
+
+            for (int r = robots_desde; r <= MAX_ROBOTS; r++) {
+                config.num_robots = r;
+                if (cumple_objetivo(&config, cabecera->simulaciones,
+                                    cabecera->tasa_exito_objetivo)) {
+                    encontrado = r;
+                    break;
+                }
+            }
+
+            robots[((size_t)im * cabecera->n_velocidad + iv) *
+                   cabecera->n_caja + ic] = (uint8_t)encontrado;
+
+            fprintf(stderr, "[Proceso %d] %d mangos, %.1f cm/s, caja %.1f cm "
+                    "→ %d robots\n", proceso, config.num_mangos,
+                    config.velocidad_banda, config.tamano_caja,
+                    encontrado == TABLA_SIN_SOLUCION ? -1 : encontrado);
+
+            // Si no alcanza con el maximo, con mas mangos tampoco
+            if (encontrado == TABLA_SIN_SOLUCION) {
+                robots_desde = MAX_ROBOTS + 1;
+            } else {
+                robots_desde = encontrado;
+            }
+        }
+    }
+}
+
+// Barre todo el espacio de parametros y guarda la tabla
+int generar_tabla(const char *ruta, CabeceraTabla *cabecera,
+                  ConfiguracionSistema *config_base, int num_procesos) {
+    size_t celdas = (size_t)cabecera->n_mangos * cabecera->n_velocidad *
+                    cabecera->n_caja;
+
+    // Los procesos escriben sus celdas directo aqui
+    uint8_t *robots = mmap(NULL, celdas, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (robots == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    memset(robots, TABLA_SIN_SOLUCION, celdas);
+
+    uint32_t combinaciones = cabecera->n_velocidad * cabecera->n_caja;
+    if ((uint32_t)num_procesos > combinaciones) {
+        num_procesos = combinaciones;
+    }
+
+    printf("\n=== GENERANDO TABLA DE ROBOTS ===\n");
+    printf("Mangos: %.0f - %.0f (paso %.0f, %u puntos)\n",
+           cabecera->mangos_min,
+           cabecera->mangos_min + (cabecera->n_mangos - 1) * cabecera->mangos_paso,
+           cabecera->mangos_paso, cabecera->n_mangos);
+    printf("Velocidad: %.1f - %.1f cm/s (paso %.1f, %u puntos)\n",
+           cabecera->velocidad_min,
+           cabecera->velocidad_min +
+           (cabecera->n_velocidad - 1) * cabecera->velocidad_paso,
+           cabecera->velocidad_paso, cabecera->n_velocidad);
+    printf("Caja: %.1f - %.1f cm (paso %.1f, %u puntos)\n",
+           cabecera->caja_min,
+           cabecera->caja_min + (cabecera->n_caja - 1) * cabecera->caja_paso,
+           cabecera->caja_paso, cabecera->n_caja);
+    printf("Banda: %.1f cm | Simulaciones por celda: %u | Procesos: %d\n\n",
+           cabecera->longitud_banda, cabecera->simulaciones, num_procesos);
+    fflush(stdout);
+
+    double inicio = tiempo_actual();
+
+    pid_t pids[MAX_PROCESOS_BARRIDO];
+    int lanzados = 0;
+
+    for (int p = 0; p < num_procesos; p++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Los mensajes de los robots no sirven aqui
+            if (freopen("/dev/null", "w", stdout) == NULL) {
+                perror("freopen");
+            }
+            proceso_barrido(p, num_procesos, cabecera, config_base, robots);
+            exit(0);
+        } else if (pid > 0) {
+            pids[lanzados++] = pid;
+        } else {
+            perror("fork");
+            break;
+        }
+    }
+
+    int error = (lanzados < num_procesos);
+    for (int i = 0; i < lanzados; i++) {
+        int estado;
+        waitpid(pids[i], &estado, 0);
+        if (!WIFEXITED(estado) || WEXITSTATUS(estado) != 0) {
+            error = 1;
+        }
+    }
+
+    if (error) {
+        printf("\n✗ ERROR: El barrido no terminó\n");
+        munmap(robots, celdas);
+        return -1;
+    }
+
+    int resultado = tabla_guardar(ruta, cabecera, robots);
+    munmap(robots, celdas);
+
+    if (resultado == 0) {
+        printf("\n✓ Tabla guardada en: %s (%zu celdas, %.1fs)\n",
+               ruta, celdas, tiempo_actual() - inicio);
+    }
+    return resultado;
+}
+
+// Responde una consulta y muestra cuanto tardo
+int consultar_tabla(const char *ruta, float num_mangos, float velocidad_banda,
+                    float tamano_caja) {
+    TablaRobots tabla;
+    if (tabla_abrir(&tabla, ruta) == -1) {
+        return -1;
+    }
+
+    double inicio = tiempo_actual();
+    int robots = tabla_consultar(&tabla, num_mangos, velocidad_banda,
+                                 tamano_caja);
+    double microsegundos = (tiempo_actual() - inicio) * 1e6;
+
+    const CabeceraTabla *c = tabla.cabecera;
+    printf("Mangos: %.1f | Velocidad: %.2f cm/s | Caja: %.2f cm | Banda: %.1f cm\n",
+           num_mangos, velocidad_banda, tamano_caja, c->longitud_banda);
+
+    if (robots < 0) {
+        printf("✗ Fuera del rango de la tabla o sin solución con %d robots\n",
+               MAX_ROBOTS);
+        printf("  Rango: mangos %.0f-%.0f, velocidad %.1f-%.1f, caja %.1f-%.1f\n",
+               c->mangos_min, c->mangos_min + (c->n_mangos - 1) * c->mangos_paso,
+               c->velocidad_min,
+               c->velocidad_min + (c->n_velocidad - 1) * c->velocidad_paso,
+               c->caja_min, c->caja_min + (c->n_caja - 1) * c->caja_paso);
+    } else {
+        printf("✓ Robots necesarios: %d (≥%.0f%% éxito)\n",
+               robots, c->tasa_exito_objetivo * 100);
+    }
+    printf("Tiempo de consulta: %.2f µs\n", microsegundos);
+
+    tabla_cerrar(&tabla);
+    return robots;
+}
+
+int main(int argc, char *argv[]) {
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    if (argc < 2) {
+        printf("Uso: %s <modo> [opciones]\n", argv[0]);
+        printf("\nModos:\n");
+        printf("  1 - Generar tabla: <archivo> <mangos_min> <mangos_max> <mangos_paso>\n");
+        printf("      <vel_min> <vel_max> <vel_paso> <caja_min> <caja_max> <caja_paso>\n");
+        printf("      [longitud_banda] [simulaciones] [procesos] [semilla]\n");
+        printf("  2 - Consultar tabla: <archivo> <mangos> <velocidad> <tamano_caja>\n");
+        printf("\nEjemplos:\n");
+        printf("  %s 1 %s 5 30 5 10 20 5 40 60 10 300 3 4\n",
+               argv[0], TABLA_POR_DEFECTO);
+        printf("  %s 2 %s 17 12.5 50\n", argv[0], TABLA_POR_DEFECTO);
+        return 1;
+    }
+
+    int modo = atoi(argv[1]);
+
+    switch (modo) {
+        case 1: {
+            if (argc < 12) {
+                printf("Error: Faltan parámetros para generar la tabla\n");
+                return 1;
+            }
+
+            const char *ruta = argv[2];
+            float mangos_min = atof(argv[3]);
+            float mangos_max = atof(argv[4]);
+            float mangos_paso = atof(argv[5]);
+            float vel_min = atof(argv[6]);
+            float vel_max = atof(argv[7]);
+            float vel_paso = atof(argv[8]);
+            float caja_min = atof(argv[9]);
+            float caja_max = atof(argv[10]);
+            float caja_paso = atof(argv[11]);
+            float longitud_banda = (argc >= 13) ? atof(argv[12]) : 300.0;
+            int num_sims = (argc >= 14) ? atoi(argv[13]) : 3;
+            int num_procesos = (argc >= 15) ? atoi(argv[14]) :
+                               (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+            // NaN pasa todas las comparaciones, hay que descartarlo aparte
+            if (!isfinite(mangos_min) || !isfinite(mangos_max) ||
+                !isfinite(mangos_paso) || !isfinite(vel_min) ||
+                !isfinite(vel_max) || !isfinite(vel_paso) ||
+                !isfinite(caja_min) || !isfinite(caja_max) ||
+                !isfinite(caja_paso) || !isfinite(longitud_banda)) {
+                printf("Error: Los rangos deben ser números finitos\n");
+                return 1;
+            }
+            if (mangos_min < 1 || mangos_max > MAX_MANGOS ||
+                mangos_min > mangos_max || mangos_paso <= 0) {
+                printf("Error: Rango de mangos inválido (debe ser 1 <= min <= max <= %d)\n",
+                       MAX_MANGOS);
+                return 1;
+            }
+            if (vel_min <= 0 || vel_min > vel_max || vel_paso <= 0 ||
+                caja_min <= 0 || caja_min > caja_max || caja_paso <= 0 ||
+                longitud_banda <= 0) {
+                printf("Error: Todos los parámetros deben ser positivos y min <= max\n");
+                return 1;
+            }
+            if (num_sims <= 0) {
+                printf("Error: Número de simulaciones debe ser positivo\n");
+                return 1;
+            }
+            if (num_procesos <= 0) num_procesos = 1;
+            if (num_procesos > MAX_PROCESOS_BARRIDO) {
+                num_procesos = MAX_PROCESOS_BARRIDO;
+            }
+
+            CabeceraTabla cabecera;
+            memset(&cabecera, 0, sizeof(cabecera));
+            cabecera.magia = TABLA_MAGIA;
+            cabecera.version = TABLA_VERSION;
+            cabecera.n_mangos = puntos_eje(mangos_min, mangos_max, mangos_paso);
+            cabecera.n_velocidad = puntos_eje(vel_min, vel_max, vel_paso);
+            cabecera.n_caja = puntos_eje(caja_min, caja_max, caja_paso);
+            cabecera.mangos_min = mangos_min;
+            cabecera.mangos_paso = mangos_paso;
+            cabecera.velocidad_min = vel_min;
+            cabecera.velocidad_paso = vel_paso;
+            cabecera.caja_min = caja_min;
+            cabecera.caja_paso = caja_paso;
+            cabecera.longitud_banda = longitud_banda;
+            cabecera.tasa_exito_objetivo = 0.95;
+            cabecera.simulaciones = num_sims;
+
+            ConfiguracionSistema config;
+            config.velocidad_banda = vel_min;
+            config.tamano_caja = caja_min;
+            config.longitud_banda = longitud_banda;
+            config.num_robots = 1;
+            config.num_mangos = (int)mangos_min;
+            config.prob_fallo = 0.0;
+            config.usar_redundancia = 0;
+            config.id_linea = 0;
+            config.semilla = (argc >= 16) ? strtoul(argv[15], NULL, 10) :
+                                            (unsigned long)time(NULL);
+            config.indice_simulacion = 0;
+            config.usar_vision = 0;
+            config.posicion_camara = 0.0;
+            config.latencia_vision = 0.0;
+            config.tiempo_por_mango = 0.0;
+            config.capacidad_cola = MAX_MANGOS;
+            config.cola_vision = NULL;
+            config.secuencia_caja = 0;
+
+            return generar_tabla(ruta, &cabecera, &config, num_procesos) == 0 ?
+                   0 : 2;
+        }
+
+        case 2: {
+            if (argc < 6) {
+                printf("Error: Uso: %s 2 <archivo> <mangos> <velocidad> <tamano_caja>\n",
+                       argv[0]);
+                return 1;
+            }
+
+            int robots = consultar_tabla(argv[2], atof(argv[3]), atof(argv[4]),
+                                         atof(argv[5]));
+            return robots < 0 ? 1 : 0;
+        }
+
+        default:
+            printf("Modo inválido: %d\n", modo);
+            return 1;
+    }
+}
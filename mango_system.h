@@ -15,14 +15,77 @@
 #include <time.h>
 #include <math.h>
 #include <sys/types.h>
+#include <stdint.h>
+#include <errno.h>
 
 // Limites del sistema
 #define MAX_MANGOS 50
 #define MAX_ROBOTS 20
+#define MAX_LINEAS 8
 #define SHM_NAME "/mango_system_shm"
 #define SEM_MUTEX_NAME "/mango_mutex"
 #define SEM_ROBOT_NAME "/mango_robot_"
 
+// Flujos del generador aleatorio (los robots usan su propio id)
+#define FLUJO_MANGOS MAX_ROBOTS
+
+// Traza de eventos (opcional, para ver una corrida en una linea de tiempo)
+#define TRAZA_CAPACIDAD (1 << 18)
+#define TRAZA_BANDA MAX_ROBOTS   // "robot" que usa el proceso de la banda
+#define TRAZA_VISION (MAX_ROBOTS + 1)
+
+typedef enum {
+    TRAZA_ENTRA_ZONA,
+    TRAZA_SALE_ZONA,
+    TRAZA_RECLAMO,          // el robot se asigna un mango
+    TRAZA_RECHAZO,          // no le alcanza el tiempo para ese mango
+    TRAZA_INICIO_ETIQUETA,
+    TRAZA_FIN_ETIQUETA,
+    TRAZA_ESPERA_MUTEX,
+    TRAZA_TOMA_MUTEX,
+    TRAZA_SUELTA_MUTEX,
+    TRAZA_FALLO,
+    TRAZA_DETECCION,        // la camara publica un mango en la cola
+    TRAZA_INICIO_CAJA       // mango_lineas pone una caja en la banda
+} TipoEventoTraza;
+
+typedef struct {
+    uint64_t tiempo_ns;   // desde traza_iniciar
+    int16_t tipo;
+    int16_t robot;
+    int32_t mango;        // -1 si no aplica
+} EventoTraza;
+
+// Tabla precalculada de robots necesarios (mango_planificador)
+#define TABLA_MAGIA 0x474E414DU   // "MANG"
+#define TABLA_VERSION 1
+#define TABLA_SIN_SOLUCION 0xFF
+
+// Va al inicio del archivo, seguida de n_mangos * n_velocidad * n_caja
+// bytes con los robots de cada celda (la caja es el eje que varia mas rapido)
+typedef struct {
+    uint32_t magia;
+    uint32_t version;
+    uint32_t n_mangos;
+    uint32_t n_velocidad;
+    uint32_t n_caja;
+    float mangos_min;
+    float mangos_paso;
+    float velocidad_min;
+    float velocidad_paso;
+    float caja_min;
+    float caja_paso;
+    float longitud_banda;
+    float tasa_exito_objetivo;
+    uint32_t simulaciones;
+} CabeceraTabla;
+
+typedef struct {
+    const CabeceraTabla *cabecera;
+    const uint8_t *robots;
+    size_t tamano;
+} TablaRobots;
+
 // Info de cada mango
 typedef struct {
     float x;
@@ -51,6 +114,53 @@ typedef struct {
     int num_robots_totales;
 } EstadoSistema;
 
+// Cajas de una linea que la camara puede tener a la vez: la que esta en la
+// banda y la siguiente. Asi nunca se queda con cajas que otra linea libre
+// podria tomar del despachador
+#define MAX_CAJAS_ADELANTE 2
+
+// Un mango detectado: de que caja (en el orden de la linea) y cual es
+typedef struct {
+    int secuencia;
+    int mango;
+} EntradaCola;
+
+// Etapa de vision de toda una corrida (una por linea). La camara toma las
+// cajas en orden y publica sus mangos aqui, y la banda las etiqueta en el
+// mismo orden: mientras los robots terminan la caja k la camara ya va
+// llenando la cola con la k+1. Va en memoria anonima compartida
+typedef struct {
+    sem_t mutex;
+    int capacidad;
+    EntradaCola entradas[MAX_MANGOS];   // mangos detectados sin reclamar
+    int cantidad;
+    int activa;                 // 0 para que la camara termine
+
+    // Cajas que tomo la camara, la k-esima en [k % MAX_CAJAS_ADELANTE]
+    int cajas[MAX_CAJAS_ADELANTE];
+    double inicio_deteccion[MAX_CAJAS_ADELANTE];  // reloj, -1 si no empezo
+    double fin_deteccion[MAX_CAJAS_ADELANTE];     // -1 si no termino
+    int cajas_tomadas;
+    int sin_cajas;              // ya no quedan cajas por tomar
+
+    // La caja que esta en la banda de etiquetado
+    int secuencia_en_banda;
+    int ultima_terminada;       // la banda ya la solto, no publicar mas
+    float posicion_banda;
+    double inicio_etiquetado;
+
+    // Metricas
+    int mangos_publicados;
+    int cola_maxima;
+    double cola_acumulada;      // suma de muestras de la banda
+    int muestras_cola;
+    int cajas_detectadas;       // con todos sus mangos publicados
+    double tiempo_deteccion;    // suma de esas cajas
+    int cajas_etiquetadas;
+    double tiempo_etiquetado;
+    double solape;              // deteccion de k+1 mientras se etiqueta k
+} ColaVision;
+
 // Configuracion para simular
 typedef struct {
     float velocidad_banda;
@@ -58,19 +168,78 @@ typedef struct {
     float longitud_banda;
     int num_robots;
     int num_mangos;
-    float prob_fallo;          // 0 a 1
+    float prob_fallo;          // 0 a 1, tasa de fallos por segundo
     int usar_redundancia;      // 0 o 1
+    int id_linea;              // para separar los nombres IPC de cada linea
+    unsigned long semilla;     // misma semilla = misma simulacion
+    int indice_simulacion;     // cambia los mangos y fallos entre corridas
+    
+    // Etapa de vision (proceso aparte antes de los robots)
+    int usar_vision;           // 0 o 1
+    float posicion_camara;     // cm
+    float latencia_vision;     // s desde que pasa la caja hasta el 1er mango
+    float tiempo_por_mango;    // s de deteccion por mango
+    int capacidad_cola;        // mangos publicados sin reclamar, maximo
+    ColaVision *cola_vision;   // la de la linea, NULL = una para esta caja
+    int secuencia_caja;        // orden de la caja en la linea
 } ConfiguracionSistema;
 
+// Metricas de la etapa de vision (de una corrida o de la ultima caja)
+typedef struct {
+    int mangos_publicados;
+    int cola_maxima;
+    float cola_promedio;
+    float tiempo_deteccion;    // por caja, desde que pasa hasta el ultimo mango
+    int cajas_etiquetadas;
+    float solape;              // s detectando la caja siguiente
+    float fraccion_solape;     // solape / tiempo etiquetando
+} MetricasVision;
+
 // Funciones
 void inicializar_sistema(EstadoSistema *estado, ConfiguracionSistema *config);
-void generar_mangos(EstadoSistema *estado, int num_mangos, float tamano_caja);
+void generar_mangos(EstadoSistema *estado, ConfiguracionSistema *config);
 void proceso_robot(int robot_id, EstadoSistema *estado, sem_t *mutex, 
                    ConfiguracionSistema *config);
 int simular_etiquetado(ConfiguracionSistema *config, int *mangos_etiquetados);
 void calcular_posiciones_robots(EstadoSistema *estado, float longitud_banda, 
                                 int num_robots);
 float calcular_tiempo_etiquetado(Mango *mango, float tamano_caja);
+float tiempo_fallo_robot(ConfiguracionSistema *config, int robot_id);
+void obtener_metricas_vision(MetricasVision *metricas);
+
+// Etapa de vision. tomar_caja da la siguiente caja (o -1 si no hay mas) y
+// corre en el proceso de la camara
+ColaVision *crear_cola_vision(ConfiguracionSistema *config);
+void destruir_cola_vision(ColaVision *cola);
+void proceso_vision(ColaVision *cola, ConfiguracionSistema *config,
+                    int (*tomar_caja)(void *), void *fuente);
+pid_t iniciar_vision(ColaVision *cola, ConfiguracionSistema *config,
+                     int (*tomar_caja)(void *), void *fuente);
+void detener_vision(ColaVision *cola, pid_t pid);
+int siguiente_caja_vision(ColaVision *cola, int secuencia);
+void terminar_caja_vision(ColaVision *cola, int secuencia);
+void metricas_cola_vision(ColaVision *cola, MetricasVision *metricas);
+
+// Aleatorio sin estado: depende solo de (semilla, simulacion, flujo, contador)
+double aleatorio_contador(unsigned long semilla, int indice_simulacion, 
+                          int flujo, int contador);
+
+// Traza
+int traza_iniciar(int capacidad);
+void traza_evento(int tipo, int robot, int mango);
+int traza_exportar_chrome(const char *ruta, int num_robots);
+void traza_reiniciar();
+void traza_ruta(char *destino, size_t tamano, const char *base,
+                const char *sufijo);
+void traza_liberar();
+
+// Tabla de robots
+int tabla_guardar(const char *ruta, const CabeceraTabla *cabecera, 
+                  const uint8_t *robots);
+int tabla_abrir(TablaRobots *tabla, const char *ruta);
+int tabla_consultar(const TablaRobots *tabla, float num_mangos, 
+                    float velocidad_banda, float tamano_caja);
+void tabla_cerrar(TablaRobots *tabla);
 
 // Otras funciones
 void imprimir_estado(EstadoSistema *estado);
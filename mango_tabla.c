@@ -0,0 +1,157 @@
+#include "mango_system.h"
+
+// Guarda la cabecera y las celdas en el archivo binario
+int tabla_guardar(const char *ruta, const CabeceraTabla *cabecera,
+                  const uint8_t *robots) {
+    FILE *archivo = fopen(ruta, "wb");
+    if (archivo == NULL) {
+        perror("Error abriendo archivo de tabla");
+        return -1;
+    }
+
+    size_t celdas = (size_t)cabecera->n_mangos * cabecera->n_velocidad *
+                    cabecera->n_caja;
+
+    if (fwrite(cabecera, sizeof(CabeceraTabla), 1, archivo) != 1 ||
+        fwrite(robots, 1, celdas, archivo) != celdas) {
+        perror("Error escribiendo tabla");
+        fclose(archivo);
+        return -1;
+    }
+
+    fclose(archivo);
+    return 0;
+}
+
+// Un eje sirve si el minimo es un numero y el paso es positivo (con paso 0
+// o NaN la consulta dividiria por cero o convertiria NaN a int)
+static int eje_valido(float minimo, float paso) {
+    return isfinite(minimo) && isfinite(paso) && paso > 0.0f;
+}
+
+// Mapea la tabla en memoria (solo lectura) y revisa que este bien
+int tabla_abrir(TablaRobots *tabla, const char *ruta) {
+    memset(tabla, 0, sizeof(TablaRobots));
+
+    int fd = open(ruta, O_RDONLY);
+    if (fd == -1) {
+        perror("Error abriendo tabla");
+        return -1;
+    }
+
+    off_t tamano = lseek(fd, 0, SEEK_END);
+    if (tamano < (off_t)sizeof(CabeceraTabla)) {
+        fprintf(stderr, "Error: %s no es una tabla válida\n", ruta);
+        close(fd);
+        return -1;
+    }
+
+    void *datos = mmap(NULL, tamano, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (datos == MAP_FAILED) {
+        perror("mmap tabla");
+        return -1;
+    }
+
+    const CabeceraTabla *cabecera = datos;
+    size_t celdas = (size_t)cabecera->n_mangos * cabecera->n_velocidad *
+                    cabecera->n_caja;
+
+    if (cabecera->magia != TABLA_MAGIA || cabecera->version != TABLA_VERSION ||
+        celdas == 0 || (size_t)tamano != sizeof(CabeceraTabla) + celdas ||
+        !eje_valido(cabecera->mangos_min, cabecera->mangos_paso) ||
+        !eje_valido(cabecera->velocidad_min, cabecera->velocidad_paso) ||
+        !eje_valido(cabecera->caja_min, cabecera->caja_paso)) {
+        fprintf(stderr, "Error: %s no es una tabla válida\n", ruta);
+        munmap(datos, tamano);
+        return -1;
+    }
+
+    tabla->cabecera = cabecera;
+    tabla->robots = (const uint8_t *)(cabecera + 1);
+    tabla->tamano = tamano;
+    return 0;
+}
+
+void tabla_cerrar(TablaRobots *tabla) {
+    if (tabla->cabecera != NULL) {
+        munmap((void *)tabla->cabecera, tabla->tamano);
+        tabla->cabecera = NULL;
+        tabla->robots = NULL;
+    }
+}
+
+// Ubica un valor en un eje: indice de la celda de abajo y fraccion hacia
+// la de arriba. Devuelve -1 si queda fuera del rango barrido
+static int ubicar_en_eje(float valor, float minimo, float paso, uint32_t n,
+                         int *indice, float *fraccion) {
+    // NaN no cae en ningun rango y (int)NaN no esta definido
+    if (!isfinite(valor)) return -1;
+
+    if (n == 1) {
+        if (fabsf(valor - minimo) > 1e-3f) return -1;
+        *indice = 0;
+        *fraccion = 0.0f;
+        return 0;
+    }
+
+    float posicion = (valor - minimo) / paso;
+    if (posicion < -1e-3f || posicion > (n - 1) + 1e-3f) {
+        return -1;
+    }
+    if (posicion < 0) posicion = 0;
+
+    int i = (int)posicion;
+    if (i >= (int)n - 1) i = n - 2;
+    *indice = i;
+    *fraccion = posicion - i;
+    if (*fraccion > 1.0f) *fraccion = 1.0f;
+    return 0;
+}
+
+// Robots necesarios para (mangos, velocidad, caja): interpolacion trilineal
+// entre las 8 celdas vecinas, redondeada hacia arriba para no quedarse corto.
+// Devuelve -1 fuera del rango o si alguna celda vecina no tiene solucion
+int tabla_consultar(const TablaRobots *tabla, float num_mangos,
+                    float velocidad_banda, float tamano_caja) {
+    const CabeceraTabla *c = tabla->cabecera;
+    int i[3];
+    float f[3];
+
+    if (c == NULL ||
+        ubicar_en_eje(num_mangos, c->mangos_min, c->mangos_paso,
+                      c->n_mangos, &i[0], &f[0]) == -1 ||
+        ubicar_en_eje(velocidad_banda, c->velocidad_min, c->velocidad_paso,
+                      c->n_velocidad, &i[1], &f[1]) == -1 ||
+        ubicar_en_eje(tamano_caja, c->caja_min, c->caja_paso,
+                      c->n_caja, &i[2], &f[2]) == -1) {
+        return -1;
+    }
+
+    float resultado = 0.0f;
+    for (int esquina = 0; esquina < 8; esquina++) {
+        int d[3];
+        float peso = 1.0f;
+        for (int eje = 0; eje < 3; eje++) {
+            int arriba = (esquina >> eje) & 1;
+            d[eje] = i[eje] + arriba;
+            peso *= arriba ? f[eje] : 1.0f - f[eje];
+        }
+        if (peso == 0.0f) continue;
+
+        // Con un solo punto en el eje no hay celda de arriba
+        if (d[0] >= (int)c->n_mangos || d[1] >= (int)c->n_velocidad ||
+            d[2] >= (int)c->n_caja) {
+            continue;
+        }
+
+        uint8_t robots = tabla->robots[((size_t)d[0] * c->n_velocidad + d[1]) *
+                                       c->n_caja + d[2]];
+        if (robots == TABLA_SIN_SOLUCION) {
+            return -1;
+        }
+        resultado += peso * robots;
+    }
+
+    return (int)ceilf(resultado - 1e-4f);
+}
@@ -0,0 +1,209 @@
+#include "mango_system.h"
+
+// Cabecera del buffer, los eventos van justo despues
+typedef struct {
+    uint64_t inicio_ns;
+    uint32_t capacidad;
+    uint32_t siguiente;   // se incrementa de forma atomica
+} BufferTraza;
+
+// Si es NULL la traza esta apagada y traza_evento no hace nada
+static BufferTraza *buffer_traza = NULL;
+static size_t tamano_traza = 0;
+
+static uint64_t reloj_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static EventoTraza *eventos_traza() {
+    return (EventoTraza *)(buffer_traza + 1);
+}
+
+// Reserva el buffer compartido. Hay que llamarla antes de crear los robots
+// para que los procesos hijos escriban en el mismo buffer
+int traza_iniciar(int capacidad) {
+    if (buffer_traza != NULL || capacidad <= 0) {
+        return -1;
+    }
+
+    tamano_traza = sizeof(BufferTraza) + (size_t)capacidad * sizeof(EventoTraza);
+    BufferTraza *buffer = mmap(NULL, tamano_traza, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        perror("mmap traza");
+        return -1;
+    }
+
+    buffer->inicio_ns = reloj_ns();
+    buffer->capacidad = capacidad;
+    buffer->siguiente = 0;
+    buffer_traza = buffer;
+    return 0;
+}
+
+// Guarda un evento. Sin locks: cada proceso reserva su casilla con un
+// incremento atomico. Si el buffer se llena los eventos se pierden
+void traza_evento(int tipo, int robot, int mango) {
+    if (buffer_traza == NULL) {
+        return;
+    }
+
+    uint32_t i = __atomic_fetch_add(&buffer_traza->siguiente, 1,
+                                    __ATOMIC_RELAXED);
+    if (i >= buffer_traza->capacidad) {
+        return;
+    }
+
+    EventoTraza *evento = &eventos_traza()[i];
+    evento->tiempo_ns = reloj_ns() - buffer_traza->inicio_ns;
+    evento->tipo = (int16_t)tipo;
+    evento->robot = (int16_t)robot;
+    evento->mango = mango;
+}
+
+static void escribir_evento_chrome(FILE *archivo, int *primero,
+                                   const char *nombre, char fase,
+                                   EventoTraza *evento) {
+    fprintf(archivo, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,"
+            "\"pid\":1,\"tid\":%d", *primero ? "" : ",", nombre, fase,
+            evento->tiempo_ns / 1000.0, evento->robot);
+    if (fase == 'i') {
+        fprintf(archivo, ",\"s\":\"t\"");
+    }
+    if (evento->mango >= 0) {
+        fprintf(archivo, ",\"args\":{\"mango\":%d}", evento->mango);
+    }
+    fprintf(archivo, "}");
+    *primero = 0;
+}
+
+// Exporta al formato JSON de Chrome trace (abre en chrome://tracing o
+// en ui.perfetto.dev)
+int traza_exportar_chrome(const char *ruta, int num_robots) {
+    if (buffer_traza == NULL) {
+        return -1;
+    }
+
+    FILE *archivo = fopen(ruta, "w");
+    if (archivo == NULL) {
+        perror("Error abriendo archivo de traza");
+        return -1;
+    }
+
+    uint32_t total = buffer_traza->siguiente;
+    uint32_t perdidos = 0;
+    if (total > buffer_traza->capacidad) {
+        perdidos = total - buffer_traza->capacidad;
+        total = buffer_traza->capacidad;
+    }
+
+    fprintf(archivo, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    // Nombres de los hilos
+    // Ya va un evento, los siguientes llevan coma
+    int primero = 0;
+    fprintf(archivo, "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"args\":{\"name\":\"MangoNeado\"}}");
+    for (int r = 0; r < num_robots; r++) {
+        fprintf(archivo, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"tid\":%d,\"args\":{\"name\":\"Robot %d\"}}", r, r);
+    }
+    fprintf(archivo, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"tid\":%d,\"args\":{\"name\":\"Banda\"}}", TRAZA_BANDA);
+    fprintf(archivo, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"tid\":%d,\"args\":{\"name\":\"Visión\"}}", TRAZA_VISION);
+
+    for (uint32_t i = 0; i < total; i++) {
+        EventoTraza *evento = &eventos_traza()[i];
+
+        switch (evento->tipo) {
+            case TRAZA_ENTRA_ZONA:
+                escribir_evento_chrome(archivo, &primero, "zona", 'B', evento);
+                break;
+            case TRAZA_SALE_ZONA:
+                escribir_evento_chrome(archivo, &primero, "zona", 'E', evento);
+                break;
+            case TRAZA_RECLAMO:
+                escribir_evento_chrome(archivo, &primero, "reclamo", 'i', evento);
+                break;
+            case TRAZA_RECHAZO:
+                escribir_evento_chrome(archivo, &primero, "rechazo", 'i', evento);
+                break;
+            case TRAZA_INICIO_ETIQUETA:
+                escribir_evento_chrome(archivo, &primero, "etiquetar", 'B', evento);
+                break;
+            case TRAZA_FIN_ETIQUETA:
+                escribir_evento_chrome(archivo, &primero, "etiquetar", 'E', evento);
+                break;
+            case TRAZA_ESPERA_MUTEX:
+                escribir_evento_chrome(archivo, &primero, "espera mutex", 'B',
+                                       evento);
+                break;
+            case TRAZA_TOMA_MUTEX:
+                escribir_evento_chrome(archivo, &primero, "espera mutex", 'E',
+                                       evento);
+                escribir_evento_chrome(archivo, &primero, "mutex", 'B', evento);
+                break;
+            case TRAZA_SUELTA_MUTEX:
+                escribir_evento_chrome(archivo, &primero, "mutex", 'E', evento);
+                break;
+            case TRAZA_FALLO:
+                escribir_evento_chrome(archivo, &primero, "fallo", 'i', evento);
+                break;
+            case TRAZA_DETECCION:
+                escribir_evento_chrome(archivo, &primero, "detección", 'i', evento);
+                break;
+            case TRAZA_INICIO_CAJA:
+                // Marca en la fila de la banda, el numero es de caja
+                fprintf(archivo, "%s\n{\"name\":\"caja\",\"ph\":\"i\",\"ts\":%.3f,"
+                        "\"pid\":1,\"tid\":%d,\"s\":\"t\",\"args\":{\"caja\":%d}}",
+                        primero ? "" : ",", evento->tiempo_ns / 1000.0,
+                        evento->robot, evento->mango);
+                primero = 0;
+                break;
+        }
+    }
+
+    fprintf(archivo, "\n]}\n");
+    fclose(archivo);
+
+    printf("Traza guardada en: %s (%u eventos", ruta, total);
+    if (perdidos > 0) {
+        printf(", %u perdidos por buffer lleno", perdidos);
+    }
+    printf(")\n");
+    return 0;
+}
+
+// Vacia el buffer para la siguiente simulacion (mango_analysis guarda una
+// traza por corrida). Solo se puede llamar cuando ningun proceso esta
+// escribiendo: ni robots ni una camara que siga viva entre cajas
+void traza_reiniciar() {
+    if (buffer_traza != NULL) {
+        buffer_traza->inicio_ns = reloj_ns();
+        buffer_traza->siguiente = 0;
+    }
+}
+
+// Arma la ruta de una traza numerada: "traza.json" + "_linea0_caja3" da
+// "traza_linea0_caja3.json". Sin extension el sufijo va al final
+void traza_ruta(char *destino, size_t tamano, const char *base,
+                const char *sufijo) {
+    const char *punto = strrchr(base, '.');
+    const char *barra = strrchr(base, '/');
+    if (punto == NULL || (barra != NULL && punto < barra)) {
+        snprintf(destino, tamano, "%s%s", base, sufijo);
+    } else {
+        snprintf(destino, tamano, "%.*s%s%s", (int)(punto - base), base,
+                 sufijo, punto);
+    }
+}
+
+void traza_liberar() {
+    if (buffer_traza != NULL) {
+        munmap(buffer_traza, tamano_traza);
+        buffer_traza = NULL;
+    }
+}
@@ -323,6 +323,30 @@ test_csv_generation() {
     fi
 }
 
+# Test 16: Etapa de visión con cola acotada
+test_vision_pipeline() {
+    local test_name="Etapa de Visión (latencia 0.5s, cola de 5)"
+    echo -e "\n${YELLOW}Test:${NC} $test_name"
+    
+    ./mango_simulator 10 50 300 6 10 0 0 7 0.5 0.1 5 > /tmp/test16.log 2>&1
+    local result=$?
+    
+    print_test_result "$test_name" $result
+    
+    # Sin la metrica en la salida tambien es fallo
+    local cola=$(grep "Cola máxima:" /tmp/test16.log | grep -oP 'Cola máxima: \K\d+')
+    local cola_ok=1
+    if [ ! -z "$cola" ]; then
+        echo "  → Profundidad máxima de la cola: $cola"
+        if [ $cola -ge 1 ] && [ $cola -le 5 ]; then
+            cola_ok=0
+        fi
+    else
+        echo "  → No se encontró 'Cola máxima' en la salida"
+    fi
+    print_test_result "$test_name - Cola respeta capacidad" $cola_ok
+}
+
 # Función principal
 main() {
     clear
@@ -355,6 +379,10 @@ main() {
     test_redundancy_no_failure
     test_redundancy_with_failure
     
+    # Tests de vision
+    print_header "TESTS DE ETAPA DE VISIÓN"
+    test_vision_pipeline
+    
     # Tests de robustez
     print_header "TESTS DE ROBUSTEZ Y MANEJO DE ERRORES"
     test_resource_cleanup